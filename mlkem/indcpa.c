@@ -123,69 +123,64 @@ static void unpack_ciphertext(polyvec *b, poly *v,
 #define gen_a(A, B) gen_matrix(A, B, 0)
 #define gen_at(A, B) gen_matrix(A, B, 1)
 
+#define GEN_MATRIX_NBLOCKS \
+  ((12 * MLKEM_N / 8 * (1 << 12) / MLKEM_Q + SHAKE128_RATE) / SHAKE128_RATE)
+
 /*************************************************
- * Name:        gen_matrix
+ * Name:        gen_matrix_batch
  *
- * Description: Deterministically generate matrix A (or the transpose of A)
- *              from a seed. Entries of the matrix are polynomials that look
- *              uniformly random. Performs rejection sampling on output of
- *              a XOF
+ * Description: Deterministically generate the next batch of entries of
+ *              matrix A (or the transpose of A) from a seed, starting at
+ *              entry i in row-major order. If at least KECCAK_WAY entries
+ *              remain, KECCAK_WAY entries are generated using a 4-way
+ *              batched XOF; otherwise, a single entry is generated.
+ *              Performs rejection sampling on output of the XOF
  *
- * Arguments:   - polyvec *a: pointer to ouptput matrix A
+ * Arguments:   - poly *vec[KECCAK_WAY]: pointers to output polynomials for
+ *                entries i, i+1, ...
  *              - const uint8_t *seed: pointer to input seed
+ *              - unsigned int i: index of first entry to generate
  *              - int transposed: boolean deciding whether A or A^T is generated
+ *
+ * Returns the number of entries generated.
  **************************************************/
-#define GEN_MATRIX_NBLOCKS \
-  ((12 * MLKEM_N / 8 * (1 << 12) / MLKEM_Q + SHAKE128_RATE) / SHAKE128_RATE)
-// Not static for benchmarking
-void gen_matrix(polyvec *a, const uint8_t seed[MLKEM_SYMBYTES],
-                int transposed) {
-  unsigned int ctr[KECCAK_WAY], i;
-  unsigned int buflen;
+static unsigned int gen_matrix_batch(poly *vec[KECCAK_WAY],
+                                     const uint8_t seed[MLKEM_SYMBYTES],
+                                     unsigned int i, int transposed) {
+  unsigned int ctr[KECCAK_WAY];
+  unsigned int buflen, n;
   uint8_t bufx[KECCAK_WAY][GEN_MATRIX_NBLOCKS * SHAKE128_RATE];
-  int16_t *vec[KECCAK_WAY] = {NULL};
 
-  keccakx4_state statex;
   // The input data to each Keccak lane.
   // Original size; MLKEM_SYMBYTES + 2, we add padding to make align load/store.
   uint8_t seedxy[KECCAK_WAY][MLKEM_SYMBYTES + 16];
-  for (unsigned j = 0; j < KECCAK_WAY; j++) {
-    memcpy(seedxy[j], seed, MLKEM_SYMBYTES);
-  }
 
-  // TODO: All loops in this function should be unrolled for decent
-  // performance.
-  //
-  // Either add suitable pragmas, or split gen_matrix according to MLKEM_K
-  // and unroll by hand.
+  n = i + KECCAK_WAY <= MLKEM_K * MLKEM_K ? KECCAK_WAY : 1;
 
-  for (i = 0; i < (MLKEM_K * MLKEM_K / KECCAK_WAY) * KECCAK_WAY;
-       i += KECCAK_WAY) {
-    uint8_t x, y;
-
-    for (unsigned int j = 0; j < KECCAK_WAY; j++) {
-      x = (i + j) / MLKEM_K;
-      y = (i + j) % MLKEM_K;
-      if (transposed) {
-        seedxy[j][MLKEM_SYMBYTES + 0] = x;
-        seedxy[j][MLKEM_SYMBYTES + 1] = y;
-      } else {
-        seedxy[j][MLKEM_SYMBYTES + 0] = y;
-        seedxy[j][MLKEM_SYMBYTES + 1] = x;
-      }
+  for (unsigned int j = 0; j < n; j++) {
+    uint8_t x = (i + j) / MLKEM_K;
+    uint8_t y = (i + j) % MLKEM_K;
+    memcpy(seedxy[j], seed, MLKEM_SYMBYTES);
+    if (transposed) {
+      seedxy[j][MLKEM_SYMBYTES + 0] = x;
+      seedxy[j][MLKEM_SYMBYTES + 1] = y;
+    } else {
+      seedxy[j][MLKEM_SYMBYTES + 0] = y;
+      seedxy[j][MLKEM_SYMBYTES + 1] = x;
     }
+  }
+
+  if (n == KECCAK_WAY) {
+    keccakx4_state statex;
 
     shake128x4_absorb(&statex, seedxy[0], seedxy[1], seedxy[2], seedxy[3],
                       MLKEM_SYMBYTES + 2);
     shake128x4_squeezeblocks(bufx[0], bufx[1], bufx[2], bufx[3],
                              GEN_MATRIX_NBLOCKS, &statex);
 
+    buflen = GEN_MATRIX_NBLOCKS * SHAKE128_RATE;
     for (unsigned int j = 0; j < KECCAK_WAY; j++) {
-      x = (i + j) / MLKEM_K;
-      y = (i + j) % MLKEM_K;
-      vec[j] = a[x].vec[y].coeffs;
-      buflen = GEN_MATRIX_NBLOCKS * SHAKE128_RATE;
-      ctr[j] = rej_uniform(vec[j], MLKEM_N, bufx[j], buflen);
+      ctr[j] = rej_uniform(vec[j]->coeffs, MLKEM_N, bufx[j], buflen);
     }
 
     while (ctr[0] < MLKEM_N || ctr[1] < MLKEM_N || ctr[2] < MLKEM_N ||
@@ -194,51 +189,210 @@ void gen_matrix(polyvec *a, const uint8_t seed[MLKEM_SYMBYTES],
       buflen = SHAKE128_RATE;
 
       for (unsigned j = 0; j < KECCAK_WAY; j++) {
-        ctr[j] +=
-            rej_uniform(vec[j] + ctr[j], MLKEM_N - ctr[j], bufx[j], buflen);
+        ctr[j] += rej_uniform(vec[j]->coeffs + ctr[j], MLKEM_N - ctr[j],
+                              bufx[j], buflen);
       }
     }
-  }
-
-  // For left over vector, we use single keccak.
-  for (; i < MLKEM_K * MLKEM_K; i++) {
+  } else {
+    // For left over entries, we use single keccak.
     shake128ctx state;
-    uint8_t x, y;
-
-    x = i / MLKEM_K;
-    y = i % MLKEM_K;
-    vec[0] = a[x].vec[y].coeffs;
-
-    if (transposed) {
-      seedxy[0][MLKEM_SYMBYTES + 0] = x;
-      seedxy[0][MLKEM_SYMBYTES + 1] = y;
-      shake128_absorb(&state, seedxy[0], MLKEM_SYMBYTES + 2);
-    } else {
-      seedxy[0][MLKEM_SYMBYTES + 0] = y;
-      seedxy[0][MLKEM_SYMBYTES + 1] = x;
-      shake128_absorb(&state, seedxy[0], MLKEM_SYMBYTES + 2);
-    }
 
+    shake128_absorb(&state, seedxy[0], MLKEM_SYMBYTES + 2);
     shake128_squeezeblocks(bufx[0], GEN_MATRIX_NBLOCKS, &state);
     buflen = GEN_MATRIX_NBLOCKS * SHAKE128_RATE;
-    ctr[0] = rej_uniform(vec[0], MLKEM_N, bufx[0], buflen);
+    ctr[0] = rej_uniform(vec[0]->coeffs, MLKEM_N, bufx[0], buflen);
 
     while (ctr[0] < MLKEM_N) {
       shake128_squeezeblocks(bufx[0], 1, &state);
       buflen = SHAKE128_RATE;
-      ctr[0] += rej_uniform(vec[0] + ctr[0], MLKEM_N - ctr[0], bufx[0], buflen);
+      ctr[0] += rej_uniform(vec[0]->coeffs + ctr[0], MLKEM_N - ctr[0], bufx[0],
+                            buflen);
     }
   }
 
 #if defined(MLKEM_USE_NATIVE_NTT_CUSTOM_ORDER)
   // The public matrix is generated in NTT domain. If the native backend
   // uses a custom order in NTT domain, permute A accordingly.
-  for (i = 0; i < MLKEM_K; i++) {
-    for (int j = 0; j < MLKEM_K; j++) {
-      poly_permute_bitrev_to_custom(&a[i].vec[j]);
-    }
+  for (unsigned int j = 0; j < n; j++) {
+    poly_permute_bitrev_to_custom(vec[j]);
   }
 #endif /* MLKEM_USE_NATIVE_NTT_CUSTOM_ORDER */
+
+  return n;
+}
+
+/*************************************************
+ * Name:        gen_matrix
+ *
+ * Description: Deterministically generate matrix A (or the transpose of A)
+ *              from a seed. Entries of the matrix are polynomials that look
+ *              uniformly random. Performs rejection sampling on output of
+ *              a XOF
+ *
+ * Arguments:   - polyvec *a: pointer to ouptput matrix A
+ *              - const uint8_t *seed: pointer to input seed
+ *              - int transposed: boolean deciding whether A or A^T is generated
+ **************************************************/
+// Not static for benchmarking
+void gen_matrix(polyvec *a, const uint8_t seed[MLKEM_SYMBYTES],
+                int transposed) {
+  unsigned int i = 0;
+  poly *vec[KECCAK_WAY] = {NULL};
+
+  // TODO: All loops in this function should be unrolled for decent
+  // performance.
+  //
+  // Either add suitable pragmas, or split gen_matrix according to MLKEM_K
+  // and unroll by hand.
+
+  while (i < MLKEM_K * MLKEM_K) {
+    for (unsigned int j = 0; j < KECCAK_WAY && i + j < MLKEM_K * MLKEM_K;
+         j++) {
+      vec[j] = &a[(i + j) / MLKEM_K].vec[(i + j) % MLKEM_K];
+    }
+    i += gen_matrix_batch(vec, seed, i, transposed);
+  }
+}
+
+/*************************************************
+ * Name:        gen_matrix_step
+ *
+ * Description: Deterministically generate the next batch of entries of
+ *              matrix A (or the transpose of A) for the step-wise API.
+ *              Uses the same batches as gen_matrix, but only keeps two rows
+ *              of the matrix, indexed by the parity of the row index.
+ *
+ * Arguments:   - polyvec *rows: pointer to two output rows
+ *              - const uint8_t *seed: pointer to input seed
+ *              - unsigned int i: index of first entry to generate; all
+ *                rows before row i / MLKEM_K must have been consumed
+ *              - int transposed: boolean deciding whether A or A^T is generated
+ *
+ * Returns the index of the next entry to generate.
+ **************************************************/
+
+// Check that a batch never spans more than two rows
+STATIC_ASSERT(KECCAK_WAY <= 2 * MLKEM_K, gen_matrix_step_rows)
+
+static unsigned int gen_matrix_step(polyvec rows[2],
+                                    const uint8_t seed[MLKEM_SYMBYTES],
+                                    unsigned int i, int transposed) {
+  poly *vec[KECCAK_WAY] = {NULL};
+
+  for (unsigned int j = 0; j < KECCAK_WAY && i + j < MLKEM_K * MLKEM_K; j++) {
+    vec[j] = &rows[((i + j) / MLKEM_K) % 2].vec[(i + j) % MLKEM_K];
+  }
+
+  return i + gen_matrix_batch(vec, seed, i, transposed);
+}
+
+/*************************************************
+ * Name:        derive_seeds
+ *
+ * Description: Derives the public seed and the noise seed from the
+ *              key generation randomness
+ *
+ * Arguments:   - uint8_t *buf: pointer to input randomness in the first
+ *                MLKEM_SYMBYTES bytes; on output, contains the public seed
+ *                followed by the noise seed
+ **************************************************/
+static void derive_seeds(uint8_t buf[2 * MLKEM_SYMBYTES]) {
+  // Add MLKEM_K for domain separation of security levels
+  buf[MLKEM_SYMBYTES] = MLKEM_K;
+  hash_g(buf, buf, MLKEM_SYMBYTES + 1);
+}
+
+/*************************************************
+ * Name:        keypair_noise
+ *
+ * Description: Samples the secret and error vectors for key generation
+ *
+ * Arguments:   - polyvec *skpv: pointer to output secret vector
+ *              - polyvec *e: pointer to output error vector
+ *              - const uint8_t *noiseseed: pointer to input noise seed
+ *                                          (of length MLKEM_SYMBYTES)
+ **************************************************/
+static void keypair_noise(polyvec *skpv, polyvec *e,
+                          const uint8_t noiseseed[MLKEM_SYMBYTES]) {
+#if MLKEM_K == 2
+  poly_getnoise_eta1_4x(skpv->vec + 0, skpv->vec + 1, e->vec + 0, e->vec + 1,
+                        noiseseed, 0, 1, 2, 3);
+#elif MLKEM_K == 3
+  poly discard[2];
+  poly_getnoise_eta1_4x(skpv->vec + 0, skpv->vec + 1, skpv->vec + 2,
+                        e->vec + 0, noiseseed, 0, 1, 2, 3);
+  poly_getnoise_eta1_4x(e->vec + 1, e->vec + 2, discard + 0, discard + 1,
+                        noiseseed, 4, 5, 6, 7);
+#elif MLKEM_K == 4
+  poly_getnoise_eta1_4x(skpv->vec + 0, skpv->vec + 1, skpv->vec + 2,
+                        skpv->vec + 3, noiseseed, 0, 1, 2, 3);
+  poly_getnoise_eta1_4x(e->vec + 0, e->vec + 1, e->vec + 2, e->vec + 3,
+                        noiseseed, 4, 5, 6, 7);
+#endif
+}
+
+/*************************************************
+ * Name:        keypair_ntt
+ *
+ * Description: Transforms the secret and error vectors into NTT domain,
+ *              and precomputes the multiplication cache for the secret
+ *
+ * Arguments:   - polyvec *skpv: pointer to input/output secret vector
+ *              - polyvec *e: pointer to input/output error vector
+ *              - polyvec_mulcache *skpv_cache: pointer to output cache
+ **************************************************/
+static void keypair_ntt(polyvec *skpv, polyvec *e,
+                        polyvec_mulcache *skpv_cache) {
+  polyvec_ntt(skpv);
+  polyvec_ntt(e);
+  polyvec_mulcache_compute(skpv_cache, skpv);
+}
+
+/*************************************************
+ * Name:        keypair_product
+ *
+ * Description: Computes one entry of the matrix-vector product A * s
+ *
+ * Arguments:   - poly *r: pointer to output entry of the product
+ *              - const polyvec *a: pointer to input row of A
+ *              - const polyvec *skpv: pointer to input secret vector
+ *              - const polyvec_mulcache *skpv_cache: pointer to input cache
+ **************************************************/
+static void keypair_product(poly *r, const polyvec *a, const polyvec *skpv,
+                            const polyvec_mulcache *skpv_cache) {
+  polyvec_basemul_acc_montgomery_cached(r, a, skpv, skpv_cache);
+  poly_tomont(r);
+}
+
+/*************************************************
+ * Name:        keypair_pack
+ *
+ * Description: Adds the error to the public vector, and serializes the
+ *              public and secret key
+ *
+ * Arguments:   - uint8_t *pk: pointer to output public key
+ *                             (of length MLKEM_INDCPA_PUBLICKEYBYTES bytes)
+ *              - uint8_t *sk: pointer to output private key
+ *                             (of length MLKEM_INDCPA_SECRETKEYBYTES bytes)
+ *              - polyvec *pkpv: pointer to input public vector A * s
+ *              - polyvec *skpv: pointer to input secret vector
+ *              - const polyvec *e: pointer to input error vector
+ *              - const uint8_t *publicseed: pointer to input public seed
+ **************************************************/
+
+STATIC_ASSERT(NTT_BOUND + MLKEM_Q < INT16_MAX, indcpa_enc_bound_0)
+
+static void keypair_pack(uint8_t pk[MLKEM_INDCPA_PUBLICKEYBYTES],
+                         uint8_t sk[MLKEM_INDCPA_SECRETKEYBYTES],
+                         polyvec *pkpv, polyvec *skpv, const polyvec *e,
+                         const uint8_t publicseed[MLKEM_SYMBYTES]) {
+  // Arithmetic cannot overflow, see static assertion at the top
+  polyvec_add(pkpv, pkpv, e);
+  polyvec_reduce(pkpv);
+  polyvec_reduce(skpv);
+
+  pack_sk(sk, skpv);
+  pack_pk(pk, pkpv, publicseed);
 }
 
 /*************************************************
@@ -254,9 +408,6 @@ void gen_matrix(polyvec *a, const uint8_t seed[MLKEM_SYMBYTES],
  *              - const uint8_t *coins: pointer to input randomness
  *                             (of length MLKEM_SYMBYTES bytes)
  **************************************************/
-
-STATIC_ASSERT(NTT_BOUND + MLKEM_Q < INT16_MAX, indcpa_enc_bound_0)
-
 void indcpa_keypair_derand(uint8_t pk[MLKEM_INDCPA_PUBLICKEYBYTES],
                            uint8_t sk[MLKEM_INDCPA_SECRETKEYBYTES],
                            const uint8_t coins[MLKEM_SYMBYTES]) {
@@ -267,47 +418,98 @@ void indcpa_keypair_derand(uint8_t pk[MLKEM_INDCPA_PUBLICKEYBYTES],
   polyvec a[MLKEM_K], e, pkpv, skpv;
   polyvec_mulcache skpv_cache;
 
-  // Add MLKEM_K for domain separation of security levels
   memcpy(buf, coins, MLKEM_SYMBYTES);
-  buf[MLKEM_SYMBYTES] = MLKEM_K;
-  hash_g(buf, buf, MLKEM_SYMBYTES + 1);
+  derive_seeds(buf);
 
   gen_a(a, publicseed);
 
+  keypair_noise(&skpv, &e, noiseseed);
+  keypair_ntt(&skpv, &e, &skpv_cache);
+
+  // matrix-vector multiplication
+  for (i = 0; i < MLKEM_K; i++) {
+    keypair_product(&pkpv.vec[i], &a[i], &skpv, &skpv_cache);
+  }
+
+  keypair_pack(pk, sk, &pkpv, &skpv, &e, publicseed);
+}
+
+/*************************************************
+ * Name:        enc_noise
+ *
+ * Description: Samples the secret vector and the errors for encryption
+ *
+ * Arguments:   - polyvec *sp: pointer to output secret vector
+ *              - polyvec *ep: pointer to output error vector
+ *              - poly *epp: pointer to output error polynomial
+ *              - const uint8_t *coins: pointer to input random coins
+ *                                      (of length MLKEM_SYMBYTES)
+ **************************************************/
+static void enc_noise(polyvec *sp, polyvec *ep, poly *epp,
+                      const uint8_t coins[MLKEM_SYMBYTES]) {
 #if MLKEM_K == 2
-  poly_getnoise_eta1_4x(skpv.vec + 0, skpv.vec + 1, e.vec + 0, e.vec + 1,
-                        noiseseed, 0, 1, 2, 3);
+  poly_getnoise_eta1122_4x(sp->vec + 0, sp->vec + 1, ep->vec + 0, ep->vec + 1,
+                           coins, 0, 1, 2, 3);
+  poly_getnoise_eta2(epp, coins, 4);
 #elif MLKEM_K == 3
-  poly_getnoise_eta1_4x(skpv.vec + 0, skpv.vec + 1, skpv.vec + 2, e.vec + 0,
-                        noiseseed, 0, 1, 2, 3);
-  poly_getnoise_eta1_4x(e.vec + 1, e.vec + 2, pkpv.vec + 0, pkpv.vec + 1,
-                        noiseseed, 4, 5, 6, 7);
+  poly discard;
+  poly_getnoise_eta1_4x(sp->vec + 0, sp->vec + 1, sp->vec + 2, ep->vec + 0,
+                        coins, 0, 1, 2, 3);
+  poly_getnoise_eta1_4x(ep->vec + 1, ep->vec + 2, epp, &discard, coins, 4, 5,
+                        6, 7);
 #elif MLKEM_K == 4
-  poly_getnoise_eta1_4x(skpv.vec + 0, skpv.vec + 1, skpv.vec + 2, skpv.vec + 3,
-                        noiseseed, 0, 1, 2, 3);
-  poly_getnoise_eta1_4x(e.vec + 0, e.vec + 1, e.vec + 2, e.vec + 3, noiseseed,
-                        4, 5, 6, 7);
+  poly_getnoise_eta1_4x(sp->vec + 0, sp->vec + 1, sp->vec + 2, sp->vec + 3,
+                        coins, 0, 1, 2, 3);
+  poly_getnoise_eta1_4x(ep->vec + 0, ep->vec + 1, ep->vec + 2, ep->vec + 3,
+                        coins, 4, 5, 6, 7);
+  poly_getnoise_eta2(epp, coins, 8);
 #endif
+}
 
-  polyvec_ntt(&skpv);
-  polyvec_ntt(&e);
+/*************************************************
+ * Name:        enc_ntt
+ *
+ * Description: Transforms the secret vector into NTT domain, and
+ *              precomputes its multiplication cache
+ *
+ * Arguments:   - polyvec *sp: pointer to input/output secret vector
+ *              - polyvec_mulcache *sp_cache: pointer to output cache
+ **************************************************/
+static void enc_ntt(polyvec *sp, polyvec_mulcache *sp_cache) {
+  polyvec_ntt(sp);
+  polyvec_mulcache_compute(sp_cache, sp);
+}
 
-  polyvec_mulcache_compute(&skpv_cache, &skpv);
+/*************************************************
+ * Name:        enc_finish
+ *
+ * Description: Transforms the products A^T * r and t^T * r back from NTT
+ *              domain, and adds the errors and the encoded message
+ *
+ * Arguments:   - polyvec *b: pointer to input/output vector b
+ *              - poly *v: pointer to input/output polynomial v
+ *              - const polyvec *ep: pointer to input error vector
+ *              - const poly *epp: pointer to input error polynomial
+ *              - const poly *k: pointer to input encoded message
+ **************************************************/
 
-  // matrix-vector multiplication
-  for (i = 0; i < MLKEM_K; i++) {
-    polyvec_basemul_acc_montgomery_cached(&pkpv.vec[i], &a[i], &skpv,
-                                          &skpv_cache);
-    poly_tomont(&pkpv.vec[i]);
-  }
+// Check that the arithmetic in enc_finish() does not overflow
+STATIC_ASSERT(INVNTT_BOUND + MLKEM_ETA1 < INT16_MAX, indcpa_enc_bound_0)
+STATIC_ASSERT(INVNTT_BOUND + MLKEM_ETA2 + MLKEM_Q < INT16_MAX,
+              indcpa_enc_bound_1)
+
+static void enc_finish(polyvec *b, poly *v, const polyvec *ep, const poly *epp,
+                       const poly *k) {
+  polyvec_invntt_tomont(b);
+  poly_invntt_tomont(v);
 
   // Arithmetic cannot overflow, see static assertion at the top
-  polyvec_add(&pkpv, &pkpv, &e);
-  polyvec_reduce(&pkpv);
-  polyvec_reduce(&skpv);
+  polyvec_add(b, b, ep);
+  poly_add(v, v, epp);
+  poly_add(v, v, k);
 
-  pack_sk(sk, &skpv);
-  pack_pk(pk, &pkpv, publicseed);
+  polyvec_reduce(b);
+  poly_reduce(v);
 }
 
 /*************************************************
@@ -325,12 +527,6 @@ void indcpa_keypair_derand(uint8_t pk[MLKEM_INDCPA_PUBLICKEYBYTES],
  *              - const uint8_t *coins: pointer to input random coins used as
  *seed (of length MLKEM_SYMBYTES) to deterministically generate all randomness
  **************************************************/
-
-// Check that the arithmetic in indcpa_enc() does not overflow
-STATIC_ASSERT(INVNTT_BOUND + MLKEM_ETA1 < INT16_MAX, indcpa_enc_bound_0)
-STATIC_ASSERT(INVNTT_BOUND + MLKEM_ETA2 + MLKEM_Q < INT16_MAX,
-              indcpa_enc_bound_1)
-
 void indcpa_enc(uint8_t c[MLKEM_INDCPA_BYTES],
                 const uint8_t m[MLKEM_INDCPA_MSGBYTES],
                 const uint8_t pk[MLKEM_INDCPA_PUBLICKEYBYTES],
@@ -345,25 +541,8 @@ void indcpa_enc(uint8_t c[MLKEM_INDCPA_BYTES],
   poly_frommsg(&k, m);
   gen_at(at, seed);
 
-#if MLKEM_K == 2
-  poly_getnoise_eta1122_4x(sp.vec + 0, sp.vec + 1, ep.vec + 0, ep.vec + 1,
-                           coins, 0, 1, 2, 3);
-  poly_getnoise_eta2(&epp, coins, 4);
-#elif MLKEM_K == 3
-  poly_getnoise_eta1_4x(sp.vec + 0, sp.vec + 1, sp.vec + 2, ep.vec + 0, coins,
-                        0, 1, 2, 3);
-  poly_getnoise_eta1_4x(ep.vec + 1, ep.vec + 2, &epp, b.vec + 0, coins, 4, 5, 6,
-                        7);
-#elif MLKEM_K == 4
-  poly_getnoise_eta1_4x(sp.vec + 0, sp.vec + 1, sp.vec + 2, sp.vec + 3, coins,
-                        0, 1, 2, 3);
-  poly_getnoise_eta1_4x(ep.vec + 0, ep.vec + 1, ep.vec + 2, ep.vec + 3, coins,
-                        4, 5, 6, 7);
-  poly_getnoise_eta2(&epp, coins, 8);
-#endif
-
-  polyvec_ntt(&sp);
-  polyvec_mulcache_compute(&sp_cache, &sp);
+  enc_noise(&sp, &ep, &epp, coins);
+  enc_ntt(&sp, &sp_cache);
 
   // matrix-vector multiplication
   for (i = 0; i < MLKEM_K; i++) {
@@ -372,18 +551,35 @@ void indcpa_enc(uint8_t c[MLKEM_INDCPA_BYTES],
 
   polyvec_basemul_acc_montgomery_cached(&v, &pkpv, &sp, &sp_cache);
 
-  polyvec_invntt_tomont(&b);
-  poly_invntt_tomont(&v);
+  enc_finish(&b, &v, &ep, &epp, &k);
 
-  // Arithmetic cannot overflow, see static assertion at the top
-  polyvec_add(&b, &b, &ep);
-  poly_add(&v, &v, &epp);
-  poly_add(&v, &v, &k);
+  pack_ciphertext(c, &b, &v);
+}
 
-  polyvec_reduce(&b);
-  poly_reduce(&v);
+/*************************************************
+ * Name:        dec_finish
+ *
+ * Description: Transforms the product s^T * u back from NTT domain,
+ *              subtracts it from v, and decodes the message
+ *
+ * Arguments:   - uint8_t *m: pointer to output decrypted message
+ *                            (of length MLKEM_INDCPA_MSGBYTES)
+ *              - poly *mp: pointer to input product s^T * u; clobbered
+ *              - const poly *v: pointer to input polynomial v
+ **************************************************/
 
-  pack_ciphertext(c, &b, &v);
+// Check that the arithmetic in dec_finish() does not overflow
+STATIC_ASSERT(INVNTT_BOUND + MLKEM_Q < INT16_MAX, indcpa_dec_bound_0)
+
+static void dec_finish(uint8_t m[MLKEM_INDCPA_MSGBYTES], poly *mp,
+                       const poly *v) {
+  poly_invntt_tomont(mp);
+
+  // Arithmetic cannot overflow, see static assertion at the top
+  poly_sub(mp, v, mp);
+  poly_reduce(mp);
+
+  poly_tomsg(m, mp);
 }
 
 /*************************************************
@@ -399,10 +595,6 @@ void indcpa_enc(uint8_t c[MLKEM_INDCPA_BYTES],
  *              - const uint8_t *sk: pointer to input secret key
  *                                   (of length MLKEM_INDCPA_SECRETKEYBYTES)
  **************************************************/
-
-// Check that the arithmetic in indcpa_dec() does not overflow
-STATIC_ASSERT(INVNTT_BOUND + MLKEM_Q < INT16_MAX, indcpa_dec_bound_0)
-
 void indcpa_dec(uint8_t m[MLKEM_INDCPA_MSGBYTES],
                 const uint8_t c[MLKEM_INDCPA_BYTES],
                 const uint8_t sk[MLKEM_INDCPA_SECRETKEYBYTES]) {
@@ -414,11 +606,256 @@ void indcpa_dec(uint8_t m[MLKEM_INDCPA_MSGBYTES],
 
   polyvec_ntt(&b);
   polyvec_basemul_acc_montgomery(&mp, &skpv, &b);
-  poly_invntt_tomont(&mp);
 
-  // Arithmetic cannot overflow, see static assertion at the top
-  poly_sub(&mp, &v, &mp);
-  poly_reduce(&mp);
+  dec_finish(m, &mp, &v);
+}
 
-  poly_tomsg(m, &mp);
+/*
+ * Step-wise (resumable) variants of indcpa_keypair_derand, indcpa_enc and
+ * indcpa_dec.
+ *
+ * They compute the same results using the same helpers as the one-shot
+ * functions above, but only ever hold two rows of the public matrix, and
+ * perform at most one bounded unit of work per call. The order of
+ * operations differs from the one-shot functions -- noise sampling and NTTs
+ * are done before the matrix is expanded, so that each row can be consumed
+ * as soon as it is complete. The matrix is sampled in the same batches as
+ * in gen_matrix().
+ *
+ * The final step of each state machine clears the context, which holds
+ * secret intermediate values.
+ */
+
+// Step following the product for row `row`, given the next matrix entry
+#define NEXT_ROW_STEP(entry, row) \
+  ((entry) >= ((row) + 1) * MLKEM_K ? INDCPA_STEP_PRODUCT : INDCPA_STEP_MATRIX)
+
+/*************************************************
+ * Name:        indcpa_keypair_derand_start
+ *
+ * Description: Initializes a step-wise key generation
+ *
+ * Arguments:   - indcpa_keypair_ctx *ctx: pointer to context to initialize
+ *              - const uint8_t *coins: pointer to input randomness
+ *                             (of length MLKEM_SYMBYTES bytes)
+ **************************************************/
+void indcpa_keypair_derand_start(indcpa_keypair_ctx *ctx,
+                                 const uint8_t coins[MLKEM_SYMBYTES]) {
+  memcpy(ctx->buf, coins, MLKEM_SYMBYTES);
+  ctx->step = INDCPA_STEP_HASH;
+  ctx->row = 0;
+  ctx->entry = 0;
+}
+
+/*************************************************
+ * Name:        indcpa_keypair_step
+ *
+ * Description: Performs the next step of a key generation started with
+ *              indcpa_keypair_derand_start
+ *
+ * Arguments:   - indcpa_keypair_ctx *ctx: pointer to context
+ *              - uint8_t *pk: pointer to output public key
+ *                             (of length MLKEM_INDCPA_PUBLICKEYBYTES bytes)
+ *              - uint8_t *sk: pointer to output private key
+ *                             (of length MLKEM_INDCPA_SECRETKEYBYTES bytes)
+ *
+ * The same pk and sk must be passed to every step of one key generation.
+ *
+ * Returns 1 if further steps are pending, and 0 once pk and sk are written.
+ **************************************************/
+int indcpa_keypair_step(indcpa_keypair_ctx *ctx,
+                        uint8_t pk[MLKEM_INDCPA_PUBLICKEYBYTES],
+                        uint8_t sk[MLKEM_INDCPA_SECRETKEYBYTES]) {
+  const uint8_t *publicseed = ctx->buf;
+  const uint8_t *noiseseed = ctx->buf + MLKEM_SYMBYTES;
+
+  switch (ctx->step) {
+    case INDCPA_STEP_HASH:
+      derive_seeds(ctx->buf);
+      ctx->step = INDCPA_STEP_NOISE;
+      return 1;
+
+    case INDCPA_STEP_NOISE:
+      keypair_noise(&ctx->skpv, &ctx->e, noiseseed);
+      ctx->step = INDCPA_STEP_NTT;
+      return 1;
+
+    case INDCPA_STEP_NTT:
+      keypair_ntt(&ctx->skpv, &ctx->e, &ctx->skpv_cache);
+      ctx->step = INDCPA_STEP_MATRIX;
+      return 1;
+
+    case INDCPA_STEP_MATRIX:
+      ctx->entry = gen_matrix_step(ctx->a_rows, publicseed, ctx->entry, 0);
+      ctx->step = NEXT_ROW_STEP(ctx->entry, ctx->row);
+      return 1;
+
+    case INDCPA_STEP_PRODUCT:
+      keypair_product(&ctx->pkpv.vec[ctx->row], &ctx->a_rows[ctx->row % 2],
+                      &ctx->skpv, &ctx->skpv_cache);
+      ctx->row++;
+      ctx->step = ctx->row < MLKEM_K ? NEXT_ROW_STEP(ctx->entry, ctx->row)
+                                     : INDCPA_STEP_PACK;
+      return 1;
+
+    case INDCPA_STEP_PACK:
+      keypair_pack(pk, sk, &ctx->pkpv, &ctx->skpv, &ctx->e, publicseed);
+      memset(ctx, 0, sizeof(*ctx));
+      ctx->step = INDCPA_STEP_DONE;
+      return 0;
+
+    default:
+      return 0;
+  }
+}
+
+/*************************************************
+ * Name:        indcpa_enc_start
+ *
+ * Description: Initializes a step-wise encryption
+ *
+ * Arguments:   - indcpa_enc_ctx *ctx: pointer to context to initialize
+ *              - const uint8_t *m: pointer to input message
+ *                                  (of length MLKEM_INDCPA_MSGBYTES bytes)
+ *              - const uint8_t *coins: pointer to input random coins
+ *                                      (of length MLKEM_SYMBYTES)
+ **************************************************/
+void indcpa_enc_start(indcpa_enc_ctx *ctx,
+                      const uint8_t m[MLKEM_INDCPA_MSGBYTES],
+                      const uint8_t coins[MLKEM_SYMBYTES]) {
+  memcpy(ctx->m, m, MLKEM_INDCPA_MSGBYTES);
+  memcpy(ctx->coins, coins, MLKEM_SYMBYTES);
+  ctx->step = INDCPA_STEP_UNPACK;
+  ctx->row = 0;
+  ctx->entry = 0;
+}
+
+/*************************************************
+ * Name:        indcpa_enc_step
+ *
+ * Description: Performs the next step of an encryption started with
+ *              indcpa_enc_start
+ *
+ * Arguments:   - indcpa_enc_ctx *ctx: pointer to context
+ *              - uint8_t *c: pointer to output ciphertext
+ *                            (of length MLKEM_INDCPA_BYTES bytes)
+ *              - const uint8_t *pk: pointer to input public key
+ *                                   (of length MLKEM_INDCPA_PUBLICKEYBYTES)
+ *
+ * The same c and pk must be passed to every step of one encryption.
+ *
+ * Returns 1 if further steps are pending, and 0 once c is written.
+ **************************************************/
+int indcpa_enc_step(indcpa_enc_ctx *ctx, uint8_t c[MLKEM_INDCPA_BYTES],
+                    const uint8_t pk[MLKEM_INDCPA_PUBLICKEYBYTES]) {
+  switch (ctx->step) {
+    case INDCPA_STEP_UNPACK:
+      unpack_pk(&ctx->pkpv, ctx->seed, pk);
+      poly_frommsg(&ctx->k, ctx->m);
+      ctx->step = INDCPA_STEP_NOISE;
+      return 1;
+
+    case INDCPA_STEP_NOISE:
+      enc_noise(&ctx->sp, &ctx->ep, &ctx->epp, ctx->coins);
+      ctx->step = INDCPA_STEP_NTT;
+      return 1;
+
+    case INDCPA_STEP_NTT:
+      enc_ntt(&ctx->sp, &ctx->sp_cache);
+      ctx->step = INDCPA_STEP_MATRIX;
+      return 1;
+
+    case INDCPA_STEP_MATRIX:
+      ctx->entry = gen_matrix_step(ctx->at_rows, ctx->seed, ctx->entry, 1);
+      ctx->step = NEXT_ROW_STEP(ctx->entry, ctx->row);
+      return 1;
+
+    case INDCPA_STEP_PRODUCT:
+      // Rows of A^T * r, followed by t^T * r
+      if (ctx->row < MLKEM_K) {
+        polyvec_basemul_acc_montgomery_cached(
+            &ctx->b.vec[ctx->row], &ctx->at_rows[ctx->row % 2], &ctx->sp,
+            &ctx->sp_cache);
+        ctx->row++;
+        ctx->step = ctx->row < MLKEM_K ? NEXT_ROW_STEP(ctx->entry, ctx->row)
+                                       : INDCPA_STEP_PRODUCT;
+      } else {
+        polyvec_basemul_acc_montgomery_cached(&ctx->v, &ctx->pkpv, &ctx->sp,
+                                              &ctx->sp_cache);
+        ctx->step = INDCPA_STEP_INVNTT;
+      }
+      return 1;
+
+    case INDCPA_STEP_INVNTT:
+      enc_finish(&ctx->b, &ctx->v, &ctx->ep, &ctx->epp, &ctx->k);
+      ctx->step = INDCPA_STEP_PACK;
+      return 1;
+
+    case INDCPA_STEP_PACK:
+      pack_ciphertext(c, &ctx->b, &ctx->v);
+      memset(ctx, 0, sizeof(*ctx));
+      ctx->step = INDCPA_STEP_DONE;
+      return 0;
+
+    default:
+      return 0;
+  }
+}
+
+/*************************************************
+ * Name:        indcpa_dec_start
+ *
+ * Description: Initializes a step-wise decryption
+ *
+ * Arguments:   - indcpa_dec_ctx *ctx: pointer to context to initialize
+ **************************************************/
+void indcpa_dec_start(indcpa_dec_ctx *ctx) { ctx->step = INDCPA_STEP_UNPACK; }
+
+/*************************************************
+ * Name:        indcpa_dec_step
+ *
+ * Description: Performs the next step of a decryption started with
+ *              indcpa_dec_start
+ *
+ * Arguments:   - indcpa_dec_ctx *ctx: pointer to context
+ *              - uint8_t *m: pointer to output decrypted message
+ *                            (of length MLKEM_INDCPA_MSGBYTES)
+ *              - const uint8_t *c: pointer to input ciphertext
+ *                                  (of length MLKEM_INDCPA_BYTES)
+ *              - const uint8_t *sk: pointer to input secret key
+ *                                   (of length MLKEM_INDCPA_SECRETKEYBYTES)
+ *
+ * The same m, c and sk must be passed to every step of one decryption.
+ *
+ * Returns 1 if further steps are pending, and 0 once m is written.
+ **************************************************/
+int indcpa_dec_step(indcpa_dec_ctx *ctx, uint8_t m[MLKEM_INDCPA_MSGBYTES],
+                    const uint8_t c[MLKEM_INDCPA_BYTES],
+                    const uint8_t sk[MLKEM_INDCPA_SECRETKEYBYTES]) {
+  switch (ctx->step) {
+    case INDCPA_STEP_UNPACK:
+      unpack_ciphertext(&ctx->b, &ctx->v, c);
+      unpack_sk(&ctx->skpv, sk);
+      ctx->step = INDCPA_STEP_NTT;
+      return 1;
+
+    case INDCPA_STEP_NTT:
+      polyvec_ntt(&ctx->b);
+      ctx->step = INDCPA_STEP_PRODUCT;
+      return 1;
+
+    case INDCPA_STEP_PRODUCT:
+      polyvec_basemul_acc_montgomery(&ctx->mp, &ctx->skpv, &ctx->b);
+      ctx->step = INDCPA_STEP_INVNTT;
+      return 1;
+
+    case INDCPA_STEP_INVNTT:
+      dec_finish(m, &ctx->mp, &ctx->v);
+      memset(ctx, 0, sizeof(*ctx));
+      ctx->step = INDCPA_STEP_DONE;
+      return 0;
+
+    default:
+      return 0;
+  }
 }
@@ -25,4 +25,67 @@ void indcpa_dec(uint8_t m[MLKEM_INDCPA_MSGBYTES],
                 const uint8_t c[MLKEM_INDCPA_BYTES],
                 const uint8_t sk[MLKEM_INDCPA_SECRETKEYBYTES]);
 
+// REF-CHANGE: The step-wise API below does not exist in the reference
+// implementation. See kem.h for a description.
+
+// Identifiers of the step a context performs next
+#define INDCPA_STEP_HASH 0
+#define INDCPA_STEP_UNPACK 1
+#define INDCPA_STEP_NOISE 2
+#define INDCPA_STEP_NTT 3
+#define INDCPA_STEP_MATRIX 4
+#define INDCPA_STEP_PRODUCT 5
+#define INDCPA_STEP_INVNTT 6
+#define INDCPA_STEP_PACK 7
+#define INDCPA_STEP_DONE 8
+
+typedef struct {
+  polyvec a_rows[2], e, pkpv, skpv;
+  polyvec_mulcache skpv_cache;
+  uint8_t buf[2 * MLKEM_SYMBYTES] ALIGN;
+  unsigned int step, row, entry;
+} indcpa_keypair_ctx;
+
+typedef struct {
+  polyvec at_rows[2], sp, pkpv, ep, b;
+  polyvec_mulcache sp_cache;
+  poly v, k, epp;
+  uint8_t seed[MLKEM_SYMBYTES] ALIGN;
+  uint8_t coins[MLKEM_SYMBYTES] ALIGN;
+  uint8_t m[MLKEM_INDCPA_MSGBYTES] ALIGN;
+  unsigned int step, row, entry;
+} indcpa_enc_ctx;
+
+typedef struct {
+  polyvec b, skpv;
+  poly v, mp;
+  unsigned int step;
+} indcpa_dec_ctx;
+
+#define indcpa_keypair_derand_start MLKEM_NAMESPACE(indcpa_keypair_derand_start)
+void indcpa_keypair_derand_start(indcpa_keypair_ctx *ctx,
+                                 const uint8_t coins[MLKEM_SYMBYTES]);
+
+#define indcpa_keypair_step MLKEM_NAMESPACE(indcpa_keypair_step)
+int indcpa_keypair_step(indcpa_keypair_ctx *ctx,
+                        uint8_t pk[MLKEM_INDCPA_PUBLICKEYBYTES],
+                        uint8_t sk[MLKEM_INDCPA_SECRETKEYBYTES]);
+
+#define indcpa_enc_start MLKEM_NAMESPACE(indcpa_enc_start)
+void indcpa_enc_start(indcpa_enc_ctx *ctx,
+                      const uint8_t m[MLKEM_INDCPA_MSGBYTES],
+                      const uint8_t coins[MLKEM_SYMBYTES]);
+
+#define indcpa_enc_step MLKEM_NAMESPACE(indcpa_enc_step)
+int indcpa_enc_step(indcpa_enc_ctx *ctx, uint8_t c[MLKEM_INDCPA_BYTES],
+                    const uint8_t pk[MLKEM_INDCPA_PUBLICKEYBYTES]);
+
+#define indcpa_dec_start MLKEM_NAMESPACE(indcpa_dec_start)
+void indcpa_dec_start(indcpa_dec_ctx *ctx);
+
+#define indcpa_dec_step MLKEM_NAMESPACE(indcpa_dec_step)
+int indcpa_dec_step(indcpa_dec_ctx *ctx, uint8_t m[MLKEM_INDCPA_MSGBYTES],
+                    const uint8_t c[MLKEM_INDCPA_BYTES],
+                    const uint8_t sk[MLKEM_INDCPA_SECRETKEYBYTES]);
+
 #endif
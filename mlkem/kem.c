@@ -8,6 +8,88 @@
 #include "randombytes.h"
 #include "symmetric.h"
 #include "verify.h"
+
+/*************************************************
+ * Name:        keypair_finish
+ *
+ * Description: Completes the secret key with the public key, its hash,
+ *              and the value z for implicit rejection
+ *
+ * Arguments:   - const uint8_t *pk: pointer to input public key
+ *                (an already allocated array of MLKEM_PUBLICKEYBYTES bytes)
+ *              - uint8_t *sk: pointer to output private key, whose first
+ *                MLKEM_INDCPA_SECRETKEYBYTES bytes are already written
+ *              - const uint8_t *z: pointer to input randomness
+ *                (of length MLKEM_SYMBYTES bytes)
+ **************************************************/
+static void keypair_finish(const uint8_t *pk, uint8_t *sk, const uint8_t *z) {
+  memcpy(sk + MLKEM_INDCPA_SECRETKEYBYTES, pk, MLKEM_PUBLICKEYBYTES);
+  hash_h(sk + MLKEM_SECRETKEYBYTES - 2 * MLKEM_SYMBYTES, pk,
+         MLKEM_PUBLICKEYBYTES);
+  /* Value z for pseudo-random output on reject */
+  memcpy(sk + MLKEM_SECRETKEYBYTES - MLKEM_SYMBYTES, z, MLKEM_SYMBYTES);
+}
+
+/*************************************************
+ * Name:        enc_hash
+ *
+ * Description: Derives the shared secret and the encryption coins
+ *
+ * Arguments:   - uint8_t *kr: pointer to output key and coins
+ *                (of length 2*MLKEM_SYMBYTES bytes)
+ *              - uint8_t *buf: pointer to buffer of length 2*MLKEM_SYMBYTES
+ *                bytes, holding the message in the first MLKEM_SYMBYTES
+ *              - const uint8_t *pk: pointer to input public key
+ **************************************************/
+static void enc_hash(uint8_t *kr, uint8_t *buf, const uint8_t *pk) {
+  /* Multitarget countermeasure for coins + contributory KEM */
+  hash_h(buf + MLKEM_SYMBYTES, pk, MLKEM_PUBLICKEYBYTES);
+  hash_g(kr, buf, 2 * MLKEM_SYMBYTES);
+}
+
+/*************************************************
+ * Name:        dec_hash
+ *
+ * Description: Derives the candidate shared secret and the coins for
+ *              re-encryption
+ *
+ * Arguments:   - uint8_t *kr: pointer to output key and coins
+ *                (of length 2*MLKEM_SYMBYTES bytes)
+ *              - uint8_t *buf: pointer to buffer of length 2*MLKEM_SYMBYTES
+ *                bytes, holding the decrypted message in the first
+ *                MLKEM_SYMBYTES
+ *              - const uint8_t *sk: pointer to input private key
+ **************************************************/
+static void dec_hash(uint8_t *kr, uint8_t *buf, const uint8_t *sk) {
+  /* Multitarget countermeasure for coins + contributory KEM */
+  memcpy(buf + MLKEM_SYMBYTES, sk + MLKEM_SECRETKEYBYTES - 2 * MLKEM_SYMBYTES,
+         MLKEM_SYMBYTES);
+  hash_g(kr, buf, 2 * MLKEM_SYMBYTES);
+}
+
+/*************************************************
+ * Name:        dec_finish
+ *
+ * Description: Compares the ciphertext against its re-encryption, and
+ *              selects the shared secret or the rejection key
+ *
+ * Arguments:   - uint8_t *ss: pointer to output shared secret
+ *              - const uint8_t *ct: pointer to input cipher text
+ *              - const uint8_t *cmp: pointer to input re-encrypted cipher text
+ *              - const uint8_t *kr: pointer to input candidate key
+ *              - const uint8_t *sk: pointer to input private key
+ **************************************************/
+static void dec_finish(uint8_t *ss, const uint8_t *ct, const uint8_t *cmp,
+                       const uint8_t *kr, const uint8_t *sk) {
+  int fail = verify(ct, cmp, MLKEM_CIPHERTEXTBYTES);
+
+  /* Compute rejection key */
+  rkprf(ss, sk + MLKEM_SECRETKEYBYTES - MLKEM_SYMBYTES, ct);
+
+  /* Copy true key to return buffer if fail is false */
+  cmov(ss, kr, MLKEM_SYMBYTES, !fail);
+}
+
 /*************************************************
  * Name:        crypto_kem_keypair_derand
  *
@@ -26,12 +108,7 @@
  **************************************************/
 int crypto_kem_keypair_derand(uint8_t *pk, uint8_t *sk, const uint8_t *coins) {
   indcpa_keypair_derand(pk, sk, coins);
-  memcpy(sk + MLKEM_INDCPA_SECRETKEYBYTES, pk, MLKEM_PUBLICKEYBYTES);
-  hash_h(sk + MLKEM_SECRETKEYBYTES - 2 * MLKEM_SYMBYTES, pk,
-         MLKEM_PUBLICKEYBYTES);
-  /* Value z for pseudo-random output on reject */
-  memcpy(sk + MLKEM_SECRETKEYBYTES - MLKEM_SYMBYTES, coins + MLKEM_SYMBYTES,
-         MLKEM_SYMBYTES);
+  keypair_finish(pk, sk, coins + MLKEM_SYMBYTES);
   return 0;
 }
 
@@ -80,10 +157,7 @@ int crypto_kem_enc_derand(uint8_t *ct, uint8_t *ss, const uint8_t *pk,
   uint8_t kr[2 * MLKEM_SYMBYTES] ALIGN;
 
   memcpy(buf, coins, MLKEM_SYMBYTES);
-
-  /* Multitarget countermeasure for coins + contributory KEM */
-  hash_h(buf + MLKEM_SYMBYTES, pk, MLKEM_PUBLICKEYBYTES);
-  hash_g(kr, buf, 2 * MLKEM_SYMBYTES);
+  enc_hash(kr, buf, pk);
 
   /* coins are in kr+MLKEM_SYMBYTES */
   indcpa_enc(ct, buf, pk, kr + MLKEM_SYMBYTES);
@@ -132,7 +206,6 @@ int crypto_kem_enc(uint8_t *ct, uint8_t *ss, const uint8_t *pk) {
  * On failure, ss will contain a pseudo-random value.
  **************************************************/
 int crypto_kem_dec(uint8_t *ss, const uint8_t *ct, const uint8_t *sk) {
-  int fail;
   uint8_t buf[2 * MLKEM_SYMBYTES] ALIGN;
   /* Will contain key, coins */
   uint8_t kr[2 * MLKEM_SYMBYTES] ALIGN;
@@ -140,22 +213,253 @@ int crypto_kem_dec(uint8_t *ss, const uint8_t *ct, const uint8_t *sk) {
   const uint8_t *pk = sk + MLKEM_INDCPA_SECRETKEYBYTES;
 
   indcpa_dec(buf, ct, sk);
-
-  /* Multitarget countermeasure for coins + contributory KEM */
-  memcpy(buf + MLKEM_SYMBYTES, sk + MLKEM_SECRETKEYBYTES - 2 * MLKEM_SYMBYTES,
-         MLKEM_SYMBYTES);
-  hash_g(kr, buf, 2 * MLKEM_SYMBYTES);
+  dec_hash(kr, buf, sk);
 
   /* coins are in kr+MLKEM_SYMBYTES */
   indcpa_enc(cmp, buf, pk, kr + MLKEM_SYMBYTES);
 
-  fail = verify(ct, cmp, MLKEM_CIPHERTEXTBYTES);
+  dec_finish(ss, ct, cmp, kr, sk);
 
-  /* Compute rejection key */
-  rkprf(ss, sk + MLKEM_SECRETKEYBYTES - MLKEM_SYMBYTES, ct);
+  return 0;
+}
 
-  /* Copy true key to return buffer if fail is false */
-  cmov(ss, kr, MLKEM_SYMBYTES, !fail);
+/*************************************************
+ * Name:        crypto_kem_keypair_derand_start
+ *
+ * Description: Initializes a step-wise key generation; see kem.h
+ *
+ * Arguments:   - crypto_kem_keypair_ctx *ctx: pointer to context to initialize
+ *              - uint8_t *pk: pointer to output public key
+ *                (an already allocated array of MLKEM_PUBLICKEYBYTES bytes)
+ *              - uint8_t *sk: pointer to output private key
+ *                (an already allocated array of MLKEM_SECRETKEYBYTES bytes)
+ *              - uint8_t *coins: pointer to input randomness
+ *                (an already allocated array filled with 2*MLKEM_SYMBYTES
+ *random bytes)
+ **
+ * Returns 0 (success)
+ **************************************************/
+int crypto_kem_keypair_derand_start(crypto_kem_keypair_ctx *ctx, uint8_t *pk,
+                                    uint8_t *sk, const uint8_t *coins) {
+  indcpa_keypair_derand_start(&ctx->indcpa, coins);
+  memcpy(ctx->z, coins + MLKEM_SYMBYTES, MLKEM_SYMBYTES);
+  ctx->pk = pk;
+  ctx->sk = sk;
+  ctx->step = CRYPTO_KEM_STEP_INDCPA_KEYPAIR;
+  return 0;
+}
 
+/*************************************************
+ * Name:        crypto_kem_keypair_start
+ *
+ * Description: Initializes a step-wise key generation with fresh
+ *              randomness; see kem.h
+ *
+ * Arguments:   - crypto_kem_keypair_ctx *ctx: pointer to context to initialize
+ *              - uint8_t *pk: pointer to output public key
+ *                (an already allocated array of MLKEM_PUBLICKEYBYTES bytes)
+ *              - uint8_t *sk: pointer to output private key
+ *                (an already allocated array of MLKEM_SECRETKEYBYTES bytes)
+ *
+ * Returns 0 (success)
+ **************************************************/
+int crypto_kem_keypair_start(crypto_kem_keypair_ctx *ctx, uint8_t *pk,
+                             uint8_t *sk) {
+  uint8_t coins[2 * MLKEM_SYMBYTES] ALIGN;
+  randombytes(coins, 2 * MLKEM_SYMBYTES);
+  crypto_kem_keypair_derand_start(ctx, pk, sk, coins);
+  return 0;
+}
+
+/*************************************************
+ * Name:        crypto_kem_keypair_step
+ *
+ * Description: Performs the next step of a key generation started with
+ *              crypto_kem_keypair_start or crypto_kem_keypair_derand_start
+ *
+ * Arguments:   - crypto_kem_keypair_ctx *ctx: pointer to context
+ *
+ * Returns 1 if further steps are pending, and 0 once pk and sk are written.
+ **************************************************/
+int crypto_kem_keypair_step(crypto_kem_keypair_ctx *ctx) {
+  switch (ctx->step) {
+    case CRYPTO_KEM_STEP_INDCPA_KEYPAIR:
+      if (!indcpa_keypair_step(&ctx->indcpa, ctx->pk, ctx->sk)) {
+        ctx->step = CRYPTO_KEM_STEP_HASH_PK;
+      }
+      return 1;
+
+    case CRYPTO_KEM_STEP_HASH_PK:
+      keypair_finish(ctx->pk, ctx->sk, ctx->z);
+      memset(ctx->z, 0, sizeof(ctx->z));
+      ctx->step = CRYPTO_KEM_STEP_DONE;
+      return 0;
+
+    default:
+      return 0;
+  }
+}
+
+/*************************************************
+ * Name:        crypto_kem_enc_derand_start
+ *
+ * Description: Initializes a step-wise encapsulation; see kem.h
+ *
+ * Arguments:   - crypto_kem_enc_ctx *ctx: pointer to context to initialize
+ *              - uint8_t *ct: pointer to output cipher text
+ *                (an already allocated array of MLKEM_CIPHERTEXTBYTES bytes)
+ *              - uint8_t *ss: pointer to output shared secret
+ *                (an already allocated array of MLKEM_SSBYTES bytes)
+ *              - const uint8_t *pk: pointer to input public key
+ *                (an already allocated array of MLKEM_PUBLICKEYBYTES bytes)
+ *              - const uint8_t *coins: pointer to input randomness
+ *                (an already allocated array filled with MLKEM_SYMBYTES random
+ *bytes)
+ **
+ * Returns 0 (success)
+ **************************************************/
+int crypto_kem_enc_derand_start(crypto_kem_enc_ctx *ctx, uint8_t *ct,
+                                uint8_t *ss, const uint8_t *pk,
+                                const uint8_t *coins) {
+  memcpy(ctx->buf, coins, MLKEM_SYMBYTES);
+  ctx->ct = ct;
+  ctx->ss = ss;
+  ctx->pk = pk;
+  ctx->step = CRYPTO_KEM_STEP_HASH_PK;
+  return 0;
+}
+
+/*************************************************
+ * Name:        crypto_kem_enc_start
+ *
+ * Description: Initializes a step-wise encapsulation with fresh randomness;
+ *              see kem.h
+ *
+ * Arguments:   - crypto_kem_enc_ctx *ctx: pointer to context to initialize
+ *              - uint8_t *ct: pointer to output cipher text
+ *                (an already allocated array of MLKEM_CIPHERTEXTBYTES bytes)
+ *              - uint8_t *ss: pointer to output shared secret
+ *                (an already allocated array of MLKEM_SSBYTES bytes)
+ *              - const uint8_t *pk: pointer to input public key
+ *                (an already allocated array of MLKEM_PUBLICKEYBYTES bytes)
+ *
+ * Returns 0 (success)
+ **************************************************/
+int crypto_kem_enc_start(crypto_kem_enc_ctx *ctx, uint8_t *ct, uint8_t *ss,
+                         const uint8_t *pk) {
+  uint8_t coins[MLKEM_SYMBYTES] ALIGN;
+  randombytes(coins, MLKEM_SYMBYTES);
+  crypto_kem_enc_derand_start(ctx, ct, ss, pk, coins);
+  return 0;
+}
+
+/*************************************************
+ * Name:        crypto_kem_enc_step
+ *
+ * Description: Performs the next step of an encapsulation started with
+ *              crypto_kem_enc_start or crypto_kem_enc_derand_start
+ *
+ * Arguments:   - crypto_kem_enc_ctx *ctx: pointer to context
+ *
+ * Returns 1 if further steps are pending, and 0 once ct and ss are written.
+ **************************************************/
+int crypto_kem_enc_step(crypto_kem_enc_ctx *ctx) {
+  switch (ctx->step) {
+    case CRYPTO_KEM_STEP_HASH_PK:
+      enc_hash(ctx->kr, ctx->buf, ctx->pk);
+
+      /* coins are in kr+MLKEM_SYMBYTES */
+      indcpa_enc_start(&ctx->indcpa, ctx->buf, ctx->kr + MLKEM_SYMBYTES);
+      ctx->step = CRYPTO_KEM_STEP_INDCPA_ENC;
+      return 1;
+
+    case CRYPTO_KEM_STEP_INDCPA_ENC:
+      if (indcpa_enc_step(&ctx->indcpa, ctx->ct, ctx->pk)) {
+        return 1;
+      }
+
+      memcpy(ctx->ss, ctx->kr, MLKEM_SYMBYTES);
+      memset(ctx->buf, 0, sizeof(ctx->buf));
+      memset(ctx->kr, 0, sizeof(ctx->kr));
+      ctx->step = CRYPTO_KEM_STEP_DONE;
+      return 0;
+
+    default:
+      return 0;
+  }
+}
+
+/*************************************************
+ * Name:        crypto_kem_dec_start
+ *
+ * Description: Initializes a step-wise decapsulation; see kem.h
+ *
+ * Arguments:   - crypto_kem_dec_ctx *ctx: pointer to context to initialize
+ *              - uint8_t *ss: pointer to output shared secret
+ *                (an already allocated array of MLKEM_SSBYTES bytes)
+ *              - const uint8_t *ct: pointer to input cipher text
+ *                (an already allocated array of MLKEM_CIPHERTEXTBYTES bytes)
+ *              - const uint8_t *sk: pointer to input private key
+ *                (an already allocated array of MLKEM_SECRETKEYBYTES bytes)
+ *
+ * Returns 0 (success)
+ **************************************************/
+int crypto_kem_dec_start(crypto_kem_dec_ctx *ctx, uint8_t *ss,
+                         const uint8_t *ct, const uint8_t *sk) {
+  indcpa_dec_start(&ctx->indcpa.dec);
+  ctx->ss = ss;
+  ctx->ct = ct;
+  ctx->sk = sk;
+  ctx->step = CRYPTO_KEM_STEP_INDCPA_DEC;
   return 0;
 }
+
+/*************************************************
+ * Name:        crypto_kem_dec_step
+ *
+ * Description: Performs the next step of a decapsulation started with
+ *              crypto_kem_dec_start
+ *
+ * Arguments:   - crypto_kem_dec_ctx *ctx: pointer to context
+ *
+ * Returns 1 if further steps are pending, and 0 once ss is written.
+ *
+ * On failure, ss will contain a pseudo-random value.
+ **************************************************/
+int crypto_kem_dec_step(crypto_kem_dec_ctx *ctx) {
+  const uint8_t *sk = ctx->sk;
+  const uint8_t *pk = sk + MLKEM_INDCPA_SECRETKEYBYTES;
+
+  switch (ctx->step) {
+    case CRYPTO_KEM_STEP_INDCPA_DEC:
+      if (!indcpa_dec_step(&ctx->indcpa.dec, ctx->buf, ctx->ct, sk)) {
+        ctx->step = CRYPTO_KEM_STEP_HASH;
+      }
+      return 1;
+
+    case CRYPTO_KEM_STEP_HASH:
+      dec_hash(ctx->kr, ctx->buf, sk);
+
+      /* coins are in kr+MLKEM_SYMBYTES */
+      indcpa_enc_start(&ctx->indcpa.enc, ctx->buf, ctx->kr + MLKEM_SYMBYTES);
+      ctx->step = CRYPTO_KEM_STEP_INDCPA_ENC;
+      return 1;
+
+    case CRYPTO_KEM_STEP_INDCPA_ENC:
+      if (!indcpa_enc_step(&ctx->indcpa.enc, ctx->cmp, pk)) {
+        ctx->step = CRYPTO_KEM_STEP_VERIFY;
+      }
+      return 1;
+
+    case CRYPTO_KEM_STEP_VERIFY:
+      dec_finish(ctx->ss, ctx->ct, ctx->cmp, ctx->kr, sk);
+      memset(ctx->buf, 0, sizeof(ctx->buf));
+      memset(ctx->kr, 0, sizeof(ctx->kr));
+      memset(ctx->cmp, 0, sizeof(ctx->cmp));
+      ctx->step = CRYPTO_KEM_STEP_DONE;
+      return 0;
+
+    default:
+      return 0;
+  }
+}
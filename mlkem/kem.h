@@ -3,6 +3,7 @@
 #define KEM_H
 
 #include <stdint.h>
+#include "indcpa.h"
 #include "params.h"
 
 #define CRYPTO_SECRETKEYBYTES MLKEM_SECRETKEYBYTES
@@ -34,4 +35,141 @@ int crypto_kem_enc(uint8_t *ct, uint8_t *ss, const uint8_t *pk);
 #define crypto_kem_dec MLKEM_NAMESPACE(dec)
 int crypto_kem_dec(uint8_t *ss, const uint8_t *ct, const uint8_t *sk);
 
+/*
+ * Step-wise (resumable) API
+ *
+ * REF-CHANGE: This API does not exist in the reference implementation.
+ *
+ * Key generation, encapsulation and decapsulation can be advanced in bounded
+ * steps, with all intermediate state held in a caller-provided context, so
+ * that a cooperative scheduler can interleave many operations and yield
+ * between steps. An operation is started with crypto_kem_XXX_start(), and
+ * crypto_kem_XXX_step() is then called until it returns 0, at which point
+ * the outputs have been written and are identical to those of the
+ * corresponding one-shot function.
+ *
+ * The context does not keep pointers into itself. It does keep the pointers
+ * passed to crypto_kem_XXX_start(), so all input and output buffers must
+ * remain valid and unmodified until the last step.
+ *
+ * The context holds secret intermediate values. These are cleared by the
+ * step returning 0; a caller abandoning an operation before that must clear
+ * the context itself.
+ *
+ * Each step performs one of the following units of work. Costs are given in
+ * terms of the underlying primitives; `make bench_components` reports the
+ * median cycle count of every step on the target.
+ *
+ * - hash:    SHA3-512 of at most 64 bytes; 1 Keccak-f1600 permutation.
+ * - hash pk: SHA3-256 of the public key; ceil(MLKEM_PUBLICKEYBYTES / 136)
+ *            Keccak-f1600 permutations (6, 9 and 12 for MLKEM_K = 2, 3, 4).
+ *            Followed by a 'hash' in encapsulation.
+ * - unpack:  Deserialization (and decompression) of keys or ciphertext.
+ * - noise:   Sampling of all noise polynomials; 1-5 SHAKE256 invocations,
+ *            mostly 4-way batched, plus centered binomial sampling.
+ * - ntt:     MLKEM_K or 2 * MLKEM_K forward NTTs.
+ * - matrix:  Sampling of 4 entries of the public matrix as one 4-way
+ *            SHAKE128 batch (typically 3 4-way Keccak-f1600 permutations),
+ *            or of the last entry for MLKEM_K = 3 as a single SHAKE128,
+ *            plus rejection sampling. These are the same batches as in the
+ *            one-shot functions.
+ * - product: One row of the matrix-vector product; MLKEM_K base
+ *            multiplications.
+ * - invntt:  Inverse NTTs, additions and reduction.
+ * - pack:    Serialization (and compression) of the output.
+ * - verify:  Constant-time comparison of the re-encrypted ciphertext, and
+ *            SHAKE256 of the ciphertext for the implicit rejection key;
+ *            ceil((MLKEM_CIPHERTEXTBYTES + 32) / 136) Keccak-f1600
+ *            permutations (6, 9 and 12 for MLKEM_K = 2, 3, 4).
+ *
+ * 'hash pk', 'verify' and 'matrix' are the most expensive steps.
+ *
+ * The step sequences are
+ *
+ * - keypair: hash, noise, ntt, MATRIX, pack, hash pk
+ * - enc:     hash pk, unpack, noise, ntt, MATRIX, product, invntt, pack
+ * - dec:     unpack, ntt, product, invntt, hash, unpack, noise, ntt, MATRIX,
+ *            product, invntt, pack, verify
+ *
+ * where MATRIX is 'matrix, product, product' for MLKEM_K = 2, and
+ * MLKEM_K * (matrix, product) for MLKEM_K = 3, 4: a 'matrix' step precedes
+ * a 'product' only if its row of the matrix has not yet been sampled.
+ *
+ * The current step of an operation is held in the `step` member of its
+ * context, as one of the CRYPTO_KEM_STEP_XXX values below; while it is
+ * CRYPTO_KEM_STEP_INDCPA_XXX, the step of the nested IND-CPA context is one
+ * of the INDCPA_STEP_XXX values from indcpa.h.
+ */
+
+#define CRYPTO_KEM_STEP_INDCPA_KEYPAIR 0
+#define CRYPTO_KEM_STEP_INDCPA_ENC 1
+#define CRYPTO_KEM_STEP_INDCPA_DEC 2
+#define CRYPTO_KEM_STEP_HASH_PK 3
+#define CRYPTO_KEM_STEP_HASH 4
+#define CRYPTO_KEM_STEP_VERIFY 5
+#define CRYPTO_KEM_STEP_DONE 6
+
+typedef struct {
+  indcpa_keypair_ctx indcpa;
+  uint8_t *pk;
+  uint8_t *sk;
+  uint8_t z[MLKEM_SYMBYTES];
+  unsigned int step;
+} crypto_kem_keypair_ctx;
+
+typedef struct {
+  indcpa_enc_ctx indcpa;
+  uint8_t *ct;
+  uint8_t *ss;
+  const uint8_t *pk;
+  uint8_t buf[2 * MLKEM_SYMBYTES] ALIGN;
+  uint8_t kr[2 * MLKEM_SYMBYTES] ALIGN;
+  unsigned int step;
+} crypto_kem_enc_ctx;
+
+typedef struct {
+  // Decryption and re-encryption are never in flight at the same time
+  union {
+    indcpa_dec_ctx dec;
+    indcpa_enc_ctx enc;
+  } indcpa;
+  uint8_t *ss;
+  const uint8_t *ct;
+  const uint8_t *sk;
+  uint8_t buf[2 * MLKEM_SYMBYTES] ALIGN;
+  uint8_t kr[2 * MLKEM_SYMBYTES] ALIGN;
+  uint8_t cmp[MLKEM_CIPHERTEXTBYTES] ALIGN;
+  unsigned int step;
+} crypto_kem_dec_ctx;
+
+#define crypto_kem_keypair_derand_start MLKEM_NAMESPACE(keypair_derand_start)
+int crypto_kem_keypair_derand_start(crypto_kem_keypair_ctx *ctx, uint8_t *pk,
+                                    uint8_t *sk, const uint8_t *coins);
+
+#define crypto_kem_keypair_start MLKEM_NAMESPACE(keypair_start)
+int crypto_kem_keypair_start(crypto_kem_keypair_ctx *ctx, uint8_t *pk,
+                             uint8_t *sk);
+
+#define crypto_kem_keypair_step MLKEM_NAMESPACE(keypair_step)
+int crypto_kem_keypair_step(crypto_kem_keypair_ctx *ctx);
+
+#define crypto_kem_enc_derand_start MLKEM_NAMESPACE(enc_derand_start)
+int crypto_kem_enc_derand_start(crypto_kem_enc_ctx *ctx, uint8_t *ct,
+                                uint8_t *ss, const uint8_t *pk,
+                                const uint8_t *coins);
+
+#define crypto_kem_enc_start MLKEM_NAMESPACE(enc_start)
+int crypto_kem_enc_start(crypto_kem_enc_ctx *ctx, uint8_t *ct, uint8_t *ss,
+                         const uint8_t *pk);
+
+#define crypto_kem_enc_step MLKEM_NAMESPACE(enc_step)
+int crypto_kem_enc_step(crypto_kem_enc_ctx *ctx);
+
+#define crypto_kem_dec_start MLKEM_NAMESPACE(dec_start)
+int crypto_kem_dec_start(crypto_kem_dec_ctx *ctx, uint8_t *ss,
+                         const uint8_t *ct, const uint8_t *sk);
+
+#define crypto_kem_dec_step MLKEM_NAMESPACE(dec_step)
+int crypto_kem_dec_step(crypto_kem_dec_ctx *ctx);
+
 #endif
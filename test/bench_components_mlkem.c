@@ -91,9 +91,92 @@ static int bench(void) {
   return 0;
 }
 
+#define NSTEPS_MAX 32
+
+// Names of the IND-CPA steps, indexed by INDCPA_STEP_XXX
+static const char *const indcpa_step_names[] = {
+    "hash", "unpack", "noise", "ntt", "matrix", "product", "invntt", "pack"};
+
+// Name of the step about to be performed by a KEM context
+static const char *step_name(unsigned int kem_step, unsigned int indcpa_step) {
+  switch (kem_step) {
+    case CRYPTO_KEM_STEP_HASH_PK:
+      return "hash pk";
+    case CRYPTO_KEM_STEP_HASH:
+      return "hash";
+    case CRYPTO_KEM_STEP_VERIFY:
+      return "verify";
+    default:
+      return indcpa_step_names[indcpa_step];
+  }
+}
+
+// Cycles of the individual steps of the step-wise KEM API. Since a step
+// cannot be repeated, each measurement covers a single call.
+#define BENCH_STEPS(txt, start, step, name)                       \
+  for (i = 0; i < NTESTS; i++) {                                  \
+    randombytes(coins, sizeof(coins));                            \
+    start;                                                        \
+    nsteps = 0;                                                   \
+    do {                                                          \
+      if (nsteps == NSTEPS_MAX) {                                 \
+        printf("ERROR " txt " has more than %u steps\n",          \
+               NSTEPS_MAX);                                       \
+        return 1;                                                 \
+      }                                                           \
+      names[nsteps] = name;                                       \
+      t0 = get_cyclecounter();                                    \
+      busy = step;                                                \
+      t1 = get_cyclecounter();                                    \
+      cyc[nsteps++][i] = t1 - t0;                                 \
+    } while (busy);                                               \
+  }                                                               \
+  for (j = 0; j < nsteps; j++) {                                  \
+    qsort(cyc[j], NTESTS, sizeof(uint64_t), cmp_uint64_t);        \
+    printf(txt " step %2u %-8s cycles=%" PRIu64 "\n", j, names[j], \
+           cyc[j][NTESTS >> 1]);                                  \
+  }
+
+static int bench_steps(void) {
+  uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+  uint8_t sk[CRYPTO_SECRETKEYBYTES];
+  uint8_t ct[CRYPTO_CIPHERTEXTBYTES];
+  uint8_t key[CRYPTO_BYTES];
+  uint8_t coins[2 * MLKEM_SYMBYTES];
+  uint64_t cyc[NSTEPS_MAX][NTESTS];
+  const char *names[NSTEPS_MAX];
+  crypto_kem_keypair_ctx kg_ctx;
+  crypto_kem_enc_ctx enc_ctx;
+  crypto_kem_dec_ctx dec_ctx;
+
+  unsigned int i, j, nsteps;
+  uint64_t t0, t1;
+  int busy;
+
+  BENCH_STEPS("keypair",
+              crypto_kem_keypair_derand_start(&kg_ctx, pk, sk, coins),
+              crypto_kem_keypair_step(&kg_ctx),
+              step_name(kg_ctx.step, kg_ctx.indcpa.step));
+  BENCH_STEPS("encaps",
+              crypto_kem_enc_derand_start(&enc_ctx, ct, key, pk, coins),
+              crypto_kem_enc_step(&enc_ctx),
+              step_name(enc_ctx.step, enc_ctx.indcpa.step));
+  BENCH_STEPS("decaps", crypto_kem_dec_start(&dec_ctx, key, ct, sk),
+              crypto_kem_dec_step(&dec_ctx),
+              step_name(dec_ctx.step, dec_ctx.step == CRYPTO_KEM_STEP_INDCPA_DEC
+                                          ? dec_ctx.indcpa.dec.step
+                                          : dec_ctx.indcpa.enc.step));
+
+  return 0;
+}
+
 int main(void) {
   enable_cyclecounter();
   bench();
+  if (bench_steps()) {
+    disable_cyclecounter();
+    return 1;
+  }
   disable_cyclecounter();
 
   return 0;
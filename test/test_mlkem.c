@@ -92,6 +92,99 @@ static int test_invalid_ciphertext(void) {
   return 0;
 }
 
+static int test_keys_steps(void) {
+  uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+  uint8_t sk[CRYPTO_SECRETKEYBYTES];
+  uint8_t ct[CRYPTO_CIPHERTEXTBYTES];
+  uint8_t key_a[CRYPTO_BYTES];
+  uint8_t key_b[CRYPTO_BYTES];
+  crypto_kem_keypair_ctx kg_ctx;
+  crypto_kem_enc_ctx enc_ctx;
+  crypto_kem_dec_ctx dec_ctx;
+
+  // Alice generates a public key
+  crypto_kem_keypair_start(&kg_ctx, pk, sk);
+  while (crypto_kem_keypair_step(&kg_ctx)) {
+  }
+
+  // Bob derives a secret key and creates a response
+  crypto_kem_enc_start(&enc_ctx, ct, key_b, pk);
+  while (crypto_kem_enc_step(&enc_ctx)) {
+  }
+
+  // Alice uses Bobs response to get her shared key
+  crypto_kem_dec_start(&dec_ctx, key_a, ct, sk);
+  while (crypto_kem_dec_step(&dec_ctx)) {
+  }
+
+  if (memcmp(key_a, key_b, CRYPTO_BYTES)) {
+    printf("ERROR keys step API\n");
+    return 1;
+  }
+
+  return 0;
+}
+
+static int test_steps(void) {
+  uint8_t pk[CRYPTO_PUBLICKEYBYTES], pk_step[CRYPTO_PUBLICKEYBYTES];
+  uint8_t sk[CRYPTO_SECRETKEYBYTES], sk_step[CRYPTO_SECRETKEYBYTES];
+  uint8_t ct[CRYPTO_CIPHERTEXTBYTES], ct_step[CRYPTO_CIPHERTEXTBYTES];
+  uint8_t key_a[CRYPTO_BYTES], key_a_step[CRYPTO_BYTES];
+  uint8_t key_b[CRYPTO_BYTES], key_b_step[CRYPTO_BYTES];
+  uint8_t kg_rand[2 * CRYPTO_BYTES], enc_rand[CRYPTO_BYTES];
+  crypto_kem_keypair_ctx kg_ctx;
+  crypto_kem_enc_ctx enc_ctx;
+  crypto_kem_dec_ctx dec_ctx;
+
+  randombytes(kg_rand, 2 * CRYPTO_BYTES);
+  randombytes(enc_rand, CRYPTO_BYTES);
+
+  crypto_kem_keypair_derand(pk, sk, kg_rand);
+  crypto_kem_enc_derand(ct, key_b, pk, enc_rand);
+  crypto_kem_dec(key_a, ct, sk);
+
+  // Advance the three operations in lock-step, as a scheduler would
+  crypto_kem_keypair_derand_start(&kg_ctx, pk_step, sk_step, kg_rand);
+  crypto_kem_enc_derand_start(&enc_ctx, ct_step, key_b_step, pk, enc_rand);
+  crypto_kem_dec_start(&dec_ctx, key_a_step, ct, sk);
+
+  int kg_busy = 1, enc_busy = 1, dec_busy = 1;
+  while (kg_busy || enc_busy || dec_busy) {
+    if (kg_busy) {
+      kg_busy = crypto_kem_keypair_step(&kg_ctx);
+    }
+    if (enc_busy) {
+      enc_busy = crypto_kem_enc_step(&enc_ctx);
+    }
+    if (dec_busy) {
+      dec_busy = crypto_kem_dec_step(&dec_ctx);
+    }
+  }
+
+  if (memcmp(pk, pk_step, CRYPTO_PUBLICKEYBYTES) ||
+      memcmp(sk, sk_step, CRYPTO_SECRETKEYBYTES) ||
+      memcmp(ct, ct_step, CRYPTO_CIPHERTEXTBYTES) ||
+      memcmp(key_b, key_b_step, CRYPTO_BYTES) ||
+      memcmp(key_a, key_a_step, CRYPTO_BYTES)) {
+    printf("ERROR step API\n");
+    return 1;
+  }
+
+  // Implicit rejection must also match
+  ct[0] ^= 1;
+  crypto_kem_dec(key_a, ct, sk);
+  crypto_kem_dec_start(&dec_ctx, key_a_step, ct, sk);
+  while (crypto_kem_dec_step(&dec_ctx)) {
+  }
+
+  if (memcmp(key_a, key_a_step, CRYPTO_BYTES)) {
+    printf("ERROR step API invalid ciphertext\n");
+    return 1;
+  }
+
+  return 0;
+}
+
 int main(void) {
   unsigned int i;
   int r;
@@ -100,6 +193,8 @@ int main(void) {
     r = test_keys();
     r |= test_invalid_sk_a();
     r |= test_invalid_ciphertext();
+    r |= test_keys_steps();
+    r |= test_steps();
     if (r) {
       return 1;
     }